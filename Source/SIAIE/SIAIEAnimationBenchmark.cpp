@@ -0,0 +1,302 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SIAIEAnimationBenchmark.h"
+#include "SIAIEAnimationBudget.h"
+#include "SIAIECharacter.h"
+#include "EngineUtils.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderCore.h"
+#include "Stats/StatsData.h"
+
+namespace
+{
+	IConsoleVariable* GetBudgetEnableVariable()
+	{
+		return IConsoleManager::Get().FindConsoleVariable(TEXT("SIAIE.AnimBudget.Enable"));
+	}
+
+	/** Whether the anim stat group reaches the game thread, which only happens while 'stat anim' is shown */
+	bool IsAnimStatGroupShown()
+	{
+#if STATS
+		if (const FGameThreadStatsData* StatsData = FLatestGameThreadStatsData::Get().Latest)
+		{
+			return StatsData->GroupNames.Contains(FName(TEXT("STATGROUP_Anim")));
+		}
+#endif
+		return false;
+	}
+
+	/** Average STAT_AnimGameThreadTime over the stats history, negative when it is not available */
+	double ReadAnimGameThreadMs()
+	{
+#if STATS
+		static const FName AnimGameThreadTimeName(TEXT("STAT_AnimGameThreadTime"));
+		if (const FGameThreadStatsData* StatsData = FLatestGameThreadStatsData::Get().Latest)
+		{
+			for (const FActiveStatGroupInfo& Group : StatsData->ActiveStatGroups)
+			{
+				for (const FComplexStatMessage& Message : Group.FlatAggregate)
+				{
+					if (Message.GetShortName() == AnimGameThreadTimeName)
+					{
+						return FPlatformTime::ToMilliseconds(Message.GetValue_Duration(EComplexStatField::IncAve));
+					}
+				}
+			}
+		}
+#endif
+		return -1.0;
+	}
+}
+
+ASIAIEAnimationBenchmark::ASIAIEAnimationBenchmark()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	SetActorHiddenInGame(true);
+
+	WarmupFrames = 60;
+	SampleFrames = 300;
+	PawnSpacing = 200.f;
+
+	CaseIndex = 0;
+	CaseFrame = 0;
+	AnimMsSum = 0.0;
+	NumAnimSamples = 0;
+	GameThreadMsSum = 0.0;
+	FrameMsSum = 0.0;
+	SavedBudgetEnable = 1;
+	bShowedAnimStats = false;
+}
+
+void ASIAIEAnimationBenchmark::StartBenchmark(TSubclassOf<ASIAIECharacter> InPawnClass, const TArray<int32>& InPawnCounts)
+{
+	PawnClass = InPawnClass;
+	PawnCounts = InPawnCounts;
+	Results.Reset();
+	CaseIndex = 0;
+
+	if (IConsoleVariable* BudgetEnable = GetBudgetEnableVariable())
+	{
+		SavedBudgetEnable = BudgetEnable->GetInt();
+	}
+
+	// Anim stats only reach the game thread while the group is shown, the warmup covers the delay
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (STATS && PlayerController != nullptr && !IsAnimStatGroupShown())
+	{
+		PlayerController->ConsoleCommand(TEXT("stat anim"));
+		bShowedAnimStats = true;
+	}
+
+	UE_LOG(LogSIAIEAnim, Display, TEXT("Animation benchmark started with %s"), *GetNameSafe(PawnClass));
+
+	BeginCase();
+	SetActorTickEnabled(true);
+}
+
+void ASIAIEAnimationBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DestroyPawns();
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (bShowedAnimStats && PlayerController != nullptr)
+	{
+		PlayerController->ConsoleCommand(TEXT("stat anim"));
+		bShowedAnimStats = false;
+	}
+
+	if (IConsoleVariable* BudgetEnable = GetBudgetEnableVariable())
+	{
+		BudgetEnable->Set(SavedBudgetEnable, ECVF_SetByCode);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASIAIEAnimationBenchmark::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (++CaseFrame > WarmupFrames)
+	{
+		// GGameThreadTime holds the previous frame, which is fully inside this case after the warmup
+		GameThreadMsSum += FPlatformTime::ToMilliseconds(GGameThreadTime);
+		FrameMsSum += DeltaSeconds * 1000.0;
+
+		const double AnimMs = ReadAnimGameThreadMs();
+		if (AnimMs >= 0.0)
+		{
+			AnimMsSum += AnimMs;
+			++NumAnimSamples;
+		}
+	}
+
+	if (CaseFrame < WarmupFrames + SampleFrames)
+	{
+		return;
+	}
+
+	FCaseResult& Result = Results.AddDefaulted_GetRef();
+	Result.NumPawns = PawnCounts[CaseIndex / 2];
+	Result.bBudgeted = (CaseIndex % 2) == 1;
+	Result.AnimMs = (NumAnimSamples > 0) ? AnimMsSum / NumAnimSamples : -1.0;
+	Result.GameThreadMs = GameThreadMsSum / FMath::Max(SampleFrames, 1);
+	Result.FrameMs = FrameMsSum / FMath::Max(SampleFrames, 1);
+
+	if (++CaseIndex < PawnCounts.Num() * 2)
+	{
+		BeginCase();
+	}
+	else
+	{
+		LogResults();
+		Destroy();
+	}
+}
+
+void ASIAIEAnimationBenchmark::BeginCase()
+{
+	const bool bBudgeted = (CaseIndex % 2) == 1;
+	if (IConsoleVariable* BudgetEnable = GetBudgetEnableVariable())
+	{
+		BudgetEnable->Set(bBudgeted ? 1 : 0, ECVF_SetByCode);
+	}
+
+	// Both halves of a pawn count share the same crowd
+	if (!bBudgeted)
+	{
+		SpawnPawns(PawnCounts[CaseIndex / 2]);
+	}
+
+	CaseFrame = 0;
+	AnimMsSum = 0.0;
+	NumAnimSamples = 0;
+	GameThreadMsSum = 0.0;
+	FrameMsSum = 0.0;
+}
+
+void ASIAIEAnimationBenchmark::SpawnPawns(int32 NumPawns)
+{
+	DestroyPawns();
+
+	FVector ViewLocation = GetActorLocation();
+	FRotator ViewRotation = GetActorRotation();
+	if (APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
+	{
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	}
+
+	// Lay the crowd out on a grid in front of the viewer, facing it
+	const FRotator Facing(0.f, ViewRotation.Yaw, 0.f);
+	const FVector Forward = Facing.Vector();
+	const FVector Right = FRotationMatrix(Facing).GetScaledAxis(EAxis::Y);
+	const int32 Columns = 20;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	SpawnedPawns.Reserve(NumPawns);
+	for (int32 Index = 0; Index < NumPawns; ++Index)
+	{
+		const int32 Row = Index / Columns;
+		const int32 Column = Index % Columns;
+		const FVector Location = ViewLocation
+			+ Forward * (500.f + Row * PawnSpacing)
+			+ Right * ((Column - Columns / 2) * PawnSpacing);
+
+		if (ASIAIECharacter* Pawn = GetWorld()->SpawnActor<ASIAIECharacter>(PawnClass, Location, (-Forward).Rotation(), SpawnParams))
+		{
+			SpawnedPawns.Add(Pawn);
+		}
+	}
+}
+
+void ASIAIEAnimationBenchmark::DestroyPawns()
+{
+	for (ASIAIECharacter* Pawn : SpawnedPawns)
+	{
+		if (Pawn != nullptr)
+		{
+			Pawn->Destroy();
+		}
+	}
+	SpawnedPawns.Reset();
+}
+
+void ASIAIEAnimationBenchmark::LogResults() const
+{
+	UE_LOG(LogSIAIEAnim, Display, TEXT("Animation benchmark, %d frames per case after %d warmup frames:"), SampleFrames, WarmupFrames);
+	for (const FCaseResult& Result : Results)
+	{
+		const FString AnimMs = (Result.AnimMs >= 0.0) ? FString::Printf(TEXT("%6.2f ms"), Result.AnimMs) : TEXT("   n/a   ");
+		UE_LOG(LogSIAIEAnim, Display, TEXT("  %4d pawns  budget %-3s  anim %s  game thread %6.2f ms  frame %6.2f ms"),
+			Result.NumPawns, Result.bBudgeted ? TEXT("on") : TEXT("off"), *AnimMs, Result.GameThreadMs, Result.FrameMs);
+	}
+
+	if (Results.ContainsByPredicate([](const FCaseResult& Result) { return Result.AnimMs < 0.0; }))
+	{
+		UE_LOG(LogSIAIEAnim, Display, TEXT("  Anim stats were not available (stats compiled out or 'stat anim' could not be shown), compare the game thread time instead"));
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Console
+
+static FAutoConsoleCommandWithWorldAndArgs CmdAnimationBenchmark(
+	TEXT("SIAIE.Anim.Benchmark"),
+	TEXT("Measures animation game thread time for crowds of AI characters with the animation budget off and on.\n")
+	TEXT("Usage: SIAIE.Anim.Benchmark [PawnCount...] [Class=/Game/Path/To/Character.Character_C] (defaults to 100 300 and the default pawn class)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr || !World->IsGameWorld())
+		{
+			return;
+		}
+
+		for (TActorIterator<ASIAIEAnimationBenchmark> It(World); It; ++It)
+		{
+			UE_LOG(LogSIAIEAnim, Warning, TEXT("An animation benchmark is already running"));
+			return;
+		}
+
+		TArray<int32> PawnCounts;
+		TSubclassOf<ASIAIECharacter> PawnClass;
+		for (const FString& Arg : Args)
+		{
+			FString ClassPath;
+			if (FParse::Value(*Arg, TEXT("Class="), ClassPath))
+			{
+				PawnClass = LoadClass<ASIAIECharacter>(nullptr, *ClassPath);
+			}
+			else if (Arg.IsNumeric())
+			{
+				PawnCounts.Add(FMath::Max(1, FCString::Atoi(*Arg)));
+			}
+		}
+
+		if (PawnCounts.Num() == 0)
+		{
+			PawnCounts = { 100, 300 };
+		}
+
+		const AGameModeBase* GameMode = World->GetAuthGameMode();
+		if (PawnClass == nullptr && GameMode != nullptr && GameMode->DefaultPawnClass != nullptr && GameMode->DefaultPawnClass->IsChildOf<ASIAIECharacter>())
+		{
+			PawnClass = *GameMode->DefaultPawnClass;
+		}
+
+		if (PawnClass == nullptr)
+		{
+			UE_LOG(LogSIAIEAnim, Warning, TEXT("No ASIAIECharacter class to spawn, pass one with Class="));
+			return;
+		}
+
+		if (ASIAIEAnimationBenchmark* Benchmark = World->SpawnActor<ASIAIEAnimationBenchmark>())
+		{
+			Benchmark->StartBenchmark(PawnClass, PawnCounts);
+		}
+	}));
@@ -0,0 +1,79 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "SIAIEAnimationBenchmark.generated.h"
+
+class ASIAIECharacter;
+
+/**
+ * Spawns crowds of AI characters in front of the local player and measures the animation game
+ * thread time (STAT_AnimGameThreadTime) with the animation budget disabled and enabled. Falls
+ * back to the whole game thread time in builds without stats. Started with SIAIE.Anim.Benchmark.
+ */
+UCLASS(notplaceable)
+class ASIAIEAnimationBenchmark : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ASIAIEAnimationBenchmark();
+
+	/** Frames skipped after each change so the budget and streaming settle */
+	UPROPERTY(EditAnywhere, Category=Benchmark)
+	int32 WarmupFrames;
+
+	/** Frames averaged for each case */
+	UPROPERTY(EditAnywhere, Category=Benchmark)
+	int32 SampleFrames;
+
+	/** Distance between spawned pawns */
+	UPROPERTY(EditAnywhere, Category=Benchmark)
+	float PawnSpacing;
+
+	/** Runs every pawn count once without and once with the animation budget */
+	void StartBenchmark(TSubclassOf<ASIAIECharacter> InPawnClass, const TArray<int32>& InPawnCounts);
+
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	struct FCaseResult
+	{
+		int32 NumPawns;
+		bool bBudgeted;
+		/** Negative when no animation stats were available */
+		double AnimMs;
+		double GameThreadMs;
+		double FrameMs;
+	};
+
+	void BeginCase();
+	void SpawnPawns(int32 NumPawns);
+	void DestroyPawns();
+	void LogResults() const;
+
+	TSubclassOf<ASIAIECharacter> PawnClass;
+	TArray<int32> PawnCounts;
+
+	UPROPERTY(Transient)
+	TArray<ASIAIECharacter*> SpawnedPawns;
+
+	TArray<FCaseResult> Results;
+	int32 CaseIndex;
+	int32 CaseFrame;
+	double AnimMsSum;
+	int32 NumAnimSamples;
+	double GameThreadMsSum;
+	double FrameMsSum;
+
+	/** Whether the benchmark turned on 'stat anim' and has to turn it off again */
+	bool bShowedAnimStats;
+
+	/** Value of SIAIE.AnimBudget.Enable before the benchmark started */
+	int32 SavedBudgetEnable;
+};
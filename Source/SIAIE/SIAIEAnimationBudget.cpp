@@ -0,0 +1,323 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SIAIEAnimationBudget.h"
+#include "SIAIECharacter.h"
+#include "Animation/AnimInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "EngineUtils.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_LOG_CATEGORY(LogSIAIEAnim);
+
+DECLARE_CYCLE_STAT(TEXT("Animation Budget Update"), STAT_SIAIEAnimationBudgetUpdate, STATGROUP_Game);
+
+static TAutoConsoleVariable<int32> CVarAnimBudgetEnable(
+	TEXT("SIAIE.AnimBudget.Enable"),
+	1,
+	TEXT("Whether the update rate and pose sharing of AI character meshes is budgeted.\n")
+	TEXT("0: every AI mesh evaluates its own anim graph every frame, 1: budgeted (default)"),
+	ECVF_Default);
+
+namespace
+{
+	/** Pawns with the same key evaluate the same anim graph on the same mesh in the same movement state */
+	struct FAnimShareKey
+	{
+		const UObject* SkeletalMesh;
+		const UClass* AnimClass;
+		uint8 MovementMode;
+		int32 SpeedBucket;
+
+		bool operator==(const FAnimShareKey& Other) const
+		{
+			return SkeletalMesh == Other.SkeletalMesh && AnimClass == Other.AnimClass
+				&& MovementMode == Other.MovementMode && SpeedBucket == Other.SpeedBucket;
+		}
+
+		friend uint32 GetTypeHash(const FAnimShareKey& Key)
+		{
+			uint32 Hash = HashCombine(GetTypeHash(Key.SkeletalMesh), GetTypeHash(Key.AnimClass));
+			return HashCombine(Hash, GetTypeHash((int32(Key.MovementMode) << 16) | Key.SpeedBucket));
+		}
+	};
+
+	struct FAnimCandidate
+	{
+		int32 Index;
+		float DistanceSq;
+		bool bRecentlyRendered;
+		bool bPlayingMontage;
+	};
+}
+
+ASIAIEAnimationBudget::ASIAIEAnimationBudget()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	SetActorHiddenInGame(true);
+
+	UpdateInterval = 0.25f;
+	MaxFullRatePawns = 8;
+	FullRateDistance = 1500.f;
+	ReducedRateDistance = 4000.f;
+	ReducedTickInterval = 1.f / 30.f;
+	SharedTickInterval = 1.f / 15.f;
+	SpeedBucketSize = 150.f;
+}
+
+ASIAIEAnimationBudget* ASIAIEAnimationBudget::Get(UWorld* World)
+{
+	if (World == nullptr || !World->IsGameWorld())
+	{
+		return nullptr;
+	}
+
+	if (ASIAIEAnimationBudget* Budget = Find(World))
+	{
+		return Budget;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	return World->SpawnActor<ASIAIEAnimationBudget>(SpawnParams);
+}
+
+ASIAIEAnimationBudget* ASIAIEAnimationBudget::Find(UWorld* World)
+{
+	if (World != nullptr)
+	{
+		for (TActorIterator<ASIAIEAnimationBudget> It(World); It; ++It)
+		{
+			return *It;
+		}
+	}
+	return nullptr;
+}
+
+void ASIAIEAnimationBudget::RegisterCharacter(ASIAIECharacter* Character)
+{
+	// The body mesh is what other players see, Mesh1P carries the FirstPerson_AnimBP graph
+	for (USkeletalMeshComponent* Mesh : { Character->GetMesh(), Character->GetMesh1P() })
+	{
+		if (Mesh != nullptr && Mesh->SkeletalMesh != nullptr)
+		{
+			FManagedMesh& Managed = Meshes.AddDefaulted_GetRef();
+			Managed.Character = Character;
+			Managed.Mesh = Mesh;
+		}
+	}
+}
+
+void ASIAIEAnimationBudget::UnregisterCharacter(ASIAIECharacter* Character)
+{
+	for (int32 Index = Meshes.Num() - 1; Index >= 0; --Index)
+	{
+		if (Meshes[Index].Character.Get() != Character)
+		{
+			continue;
+		}
+
+		// Followers would freeze on the departing leader's last pose until the next update
+		if (Meshes[Index].Tier == ESIAIEAnimTier::Leader)
+		{
+			const USkeletalMeshComponent* LeaderMesh = Meshes[Index].Mesh.Get();
+			for (FManagedMesh& Managed : Meshes)
+			{
+				if (Managed.Tier == ESIAIEAnimTier::Follower && Managed.Mesh.IsValid()
+					&& Managed.Mesh->MasterPoseComponent.Get() == LeaderMesh)
+				{
+					ApplyTier(Managed, ESIAIEAnimTier::Reduced, nullptr);
+				}
+			}
+		}
+
+		ApplyTier(Meshes[Index], ESIAIEAnimTier::Unmanaged, nullptr);
+		Meshes.RemoveAtSwap(Index);
+	}
+}
+
+void ASIAIEAnimationBudget::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetActorTickInterval(UpdateInterval);
+}
+
+void ASIAIEAnimationBudget::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for (FManagedMesh& Managed : Meshes)
+	{
+		ApplyTier(Managed, ESIAIEAnimTier::Unmanaged, nullptr);
+	}
+	Meshes.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASIAIEAnimationBudget::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	UpdateTiers();
+}
+
+void ASIAIEAnimationBudget::UpdateTiers()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SIAIEAnimationBudgetUpdate);
+
+	Meshes.RemoveAllSwap([](const FManagedMesh& Managed) { return !Managed.Character.IsValid() || !Managed.Mesh.IsValid(); });
+
+	const bool bBudgetEnabled = CVarAnimBudgetEnable.GetValueOnGameThread() != 0;
+
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		if (PlayerController != nullptr && PlayerController->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+
+	TArray<FAnimCandidate> Candidates;
+	Candidates.Reserve(Meshes.Num());
+	for (int32 Index = 0; Index < Meshes.Num(); ++Index)
+	{
+		FManagedMesh& Managed = Meshes[Index];
+		ASIAIECharacter* Character = Managed.Character.Get();
+		USkeletalMeshComponent* Mesh = Managed.Mesh.Get();
+
+		if (!bBudgetEnabled || Character->IsPlayerControlled() || Mesh->SkeletalMesh == nullptr)
+		{
+			ApplyTier(Managed, ESIAIEAnimTier::Unmanaged, nullptr);
+			continue;
+		}
+
+		// Nobody looks at this machine's view (dedicated server), poses and montages are never needed
+		if (ViewLocations.Num() == 0)
+		{
+			ApplyTier(Managed, ESIAIEAnimTier::NotRendered, nullptr);
+			continue;
+		}
+
+		const FVector Location = Character->GetActorLocation();
+		float DistanceSq = MAX_flt;
+		for (const FVector& ViewLocation : ViewLocations)
+		{
+			DistanceSq = FMath::Min(DistanceSq, FVector::DistSquared(Location, ViewLocation));
+		}
+
+		const UAnimInstance* AnimInstance = Mesh->GetAnimInstance();
+		const bool bPlayingMontage = (AnimInstance != nullptr) && AnimInstance->IsAnyMontagePlaying();
+
+		Candidates.Add({ Index, DistanceSq, Mesh->WasRecentlyRendered(FMath::Max(UpdateInterval, 0.2f)), bPlayingMontage });
+	}
+
+	// Visible pawns first, then closest first
+	Candidates.Sort([](const FAnimCandidate& A, const FAnimCandidate& B)
+	{
+		return (A.bRecentlyRendered != B.bRecentlyRendered) ? A.bRecentlyRendered : A.DistanceSq < B.DistanceSq;
+	});
+
+	TMap<FAnimShareKey, USkeletalMeshComponent*> Leaders;
+	int32 NumFullRate = 0;
+	for (const FAnimCandidate& Candidate : Candidates)
+	{
+		FManagedMesh& Managed = Meshes[Candidate.Index];
+
+		if (!Candidate.bRecentlyRendered)
+		{
+			ApplyTier(Managed, ESIAIEAnimTier::NotRendered, nullptr);
+		}
+		else if (NumFullRate < MaxFullRatePawns && Candidate.DistanceSq < FMath::Square(FullRateDistance))
+		{
+			ApplyTier(Managed, ESIAIEAnimTier::Full, nullptr);
+			++NumFullRate;
+		}
+		else if (Candidate.bPlayingMontage || Candidate.DistanceSq < FMath::Square(ReducedRateDistance))
+		{
+			// A montage on a follower would be paused, losing its pose and notifies, so these never share
+			ApplyTier(Managed, ESIAIEAnimTier::Reduced, nullptr);
+		}
+		else
+		{
+			// Rendered but far away: one mesh per group evaluates, the rest copy its pose
+			ASIAIECharacter* Character = Managed.Character.Get();
+			USkeletalMeshComponent* Mesh = Managed.Mesh.Get();
+			const UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+
+			FAnimShareKey Key;
+			Key.SkeletalMesh = Mesh->SkeletalMesh;
+			Key.AnimClass = Mesh->GetAnimClass();
+			Key.MovementMode = (Movement != nullptr) ? uint8(Movement->MovementMode) : 0;
+			Key.SpeedBucket = FMath::FloorToInt(Character->GetVelocity().Size2D() / FMath::Max(SpeedBucketSize, 1.f));
+
+			USkeletalMeshComponent*& Leader = Leaders.FindOrAdd(Key);
+			if (Leader == nullptr)
+			{
+				Leader = Mesh;
+				ApplyTier(Managed, ESIAIEAnimTier::Leader, nullptr);
+			}
+			else
+			{
+				ApplyTier(Managed, ESIAIEAnimTier::Follower, Leader);
+			}
+		}
+	}
+}
+
+void ASIAIEAnimationBudget::ApplyTier(FManagedMesh& Managed, ESIAIEAnimTier Tier, USkeletalMeshComponent* Leader)
+{
+	USkeletalMeshComponent* Mesh = Managed.Mesh.Get();
+	if (Mesh == nullptr || (Tier == Managed.Tier && Mesh->MasterPoseComponent.Get() == Leader))
+	{
+		return;
+	}
+
+	if (Managed.Tier == ESIAIEAnimTier::Unmanaged)
+	{
+		Managed.OriginalTickOption = Mesh->VisibilityBasedAnimTickOption;
+	}
+
+	float TickInterval = 0.f;
+	// Once off screen neither the pose nor montages are evaluated, they are cosmetic for AI
+	EVisibilityBasedAnimTickOption TickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+	switch (Tier)
+	{
+	case ESIAIEAnimTier::Unmanaged:
+		TickOption = Managed.OriginalTickOption;
+		break;
+	case ESIAIEAnimTier::Full:
+		break;
+	case ESIAIEAnimTier::Reduced:
+		TickInterval = ReducedTickInterval;
+		break;
+	case ESIAIEAnimTier::Leader:
+		// Followers may stay on screen after the leader leaves it, until the next update
+		TickInterval = SharedTickInterval;
+		TickOption = EVisibilityBasedAnimTickOption::AlwaysTickPose;
+		break;
+	case ESIAIEAnimTier::Follower:
+	case ESIAIEAnimTier::NotRendered:
+		TickInterval = SharedTickInterval;
+		break;
+	}
+
+	if (Mesh->MasterPoseComponent.Get() != Leader)
+	{
+		Mesh->SetMasterPoseComponent(Leader);
+	}
+
+	// Followers render the leader's pose, their own anim instance has nothing to do
+	Mesh->bPauseAnims = (Tier == ESIAIEAnimTier::Follower);
+	Mesh->VisibilityBasedAnimTickOption = TickOption;
+	Mesh->SetComponentTickInterval(TickInterval);
+
+	Managed.Tier = Tier;
+}
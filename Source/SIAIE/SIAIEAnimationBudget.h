@@ -0,0 +1,106 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "SIAIEAnimationBudget.generated.h"
+
+class ASIAIECharacter;
+class USkeletalMeshComponent;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogSIAIEAnim, Log, All);
+
+/** How much animation work one skeletal mesh of an AI pawn is allowed to do. */
+enum class ESIAIEAnimTier : uint8
+{
+	/** Untouched, used for player controlled pawns and when the budget is disabled */
+	Unmanaged,
+	/** Evaluates every frame */
+	Full,
+	/** Evaluates at ReducedTickInterval */
+	Reduced,
+	/** Evaluates at SharedTickInterval and drives the followers of its share group */
+	Leader,
+	/** Copies the pose of its group leader and skips its own anim graph */
+	Follower,
+	/** Not seen by any local viewer (off screen, dedicated server): neither pose nor montages tick */
+	NotRendered,
+};
+
+/**
+ * Per-world animation budget for AI controlled ASIAIECharacter pawns. Every animated skeletal
+ * mesh of a pawn (the body mesh and Mesh1P) is ranked by distance to the local viewers and has
+ * its update rate lowered with significance. Low significance meshes that use the same mesh,
+ * anim class and movement state share one evaluated pose through SetMasterPoseComponent.
+ * Spawned on demand on every machine, as animation is local work.
+ */
+UCLASS(config=Game, notplaceable)
+class ASIAIEAnimationBudget : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ASIAIEAnimationBudget();
+
+	/** Returns the budget of the given game world, spawning it the first time */
+	static ASIAIEAnimationBudget* Get(UWorld* World);
+
+	/** Returns the budget of the given world if there is one, never spawns */
+	static ASIAIEAnimationBudget* Find(UWorld* World);
+
+	void RegisterCharacter(ASIAIECharacter* Character);
+	void UnregisterCharacter(ASIAIECharacter* Character);
+
+	/** Seconds between significance updates */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Budget, meta=(ClampMin="0"))
+	float UpdateInterval;
+
+	/** Most significant pawns allowed to evaluate every frame */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Budget)
+	int32 MaxFullRatePawns;
+
+	/** Pawns further than this from every viewer never run at full rate */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Budget)
+	float FullRateDistance;
+
+	/** Rendered pawns further than this from every viewer share poses */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Budget)
+	float ReducedRateDistance;
+
+	/** Mesh tick interval of Reduced pawns */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Budget)
+	float ReducedTickInterval;
+
+	/** Mesh tick interval of share groups and of meshes nobody can see */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Budget)
+	float SharedTickInterval;
+
+	/** Width of the ground speed buckets used to decide whether two pawns are in the same state */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Budget, meta=(ClampMin="1"))
+	float SpeedBucketSize;
+
+public:
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	struct FManagedMesh
+	{
+		TWeakObjectPtr<ASIAIECharacter> Character;
+		TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+		ESIAIEAnimTier Tier = ESIAIEAnimTier::Unmanaged;
+		EVisibilityBasedAnimTickOption OriginalTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+	};
+
+	/** Reassigns every managed mesh to a tier */
+	void UpdateTiers();
+
+	void ApplyTier(FManagedMesh& Managed, ESIAIEAnimTier Tier, USkeletalMeshComponent* Leader);
+
+	TArray<FManagedMesh> Meshes;
+};
@@ -2,6 +2,7 @@
 
 #include "SIAIECharacter.h"
 #include "SIAIEProjectile.h"
+#include "SIAIEAnimationBudget.h"
 #include "Animation/AnimInstance.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -103,6 +104,22 @@ void ASIAIECharacter::BeginPlay()
 		VR_Gun->SetHiddenInGame(true, true);
 		Mesh1P->SetHiddenInGame(false, true);
 	}
+
+	// AI controlled pawns get the update rate of their meshes budgeted
+	if (ASIAIEAnimationBudget* AnimationBudget = ASIAIEAnimationBudget::Get(GetWorld()))
+	{
+		AnimationBudget->RegisterCharacter(this);
+	}
+}
+
+void ASIAIECharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ASIAIEAnimationBudget* AnimationBudget = ASIAIEAnimationBudget::Find(GetWorld()))
+	{
+		AnimationBudget->UnregisterCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -174,8 +191,8 @@ void ASIAIECharacter::OnFire()
 		UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
 	}
 
-	// try and play a firing animation if specified
-	if (FireAnimation != nullptr)
+	// try and play a firing animation if specified, it is purely cosmetic so skip it when the arms aren't on screen
+	if (FireAnimation != nullptr && Mesh1P->WasRecentlyRendered())
 	{
 		// Get the animation object for the arms mesh
 		UAnimInstance* AnimInstance = Mesh1P->GetAnimInstance();
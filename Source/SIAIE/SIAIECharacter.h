@@ -56,6 +56,7 @@ public:
 
 protected:
 	virtual void BeginPlay();
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
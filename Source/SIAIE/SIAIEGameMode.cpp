@@ -3,6 +3,7 @@
 #include "SIAIEGameMode.h"
 #include "SIAIEHUD.h"
 #include "SIAIECharacter.h"
+#include "SIAIEMatchRecorder.h"
 #include "UObject/ConstructorHelpers.h"
 
 ASIAIEGameMode::ASIAIEGameMode()
@@ -15,3 +16,16 @@ ASIAIEGameMode::ASIAIEGameMode()
 	// use our custom HUD class
 	HUDClass = ASIAIEHUD::StaticClass();
 }
+
+void ASIAIEGameMode::StartPlay()
+{
+	// The game mode only exists on the server, so this is where matches get recorded
+	if (ASIAIEMatchRecorder::ShouldRecord(GetWorld()))
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		GetWorld()->SpawnActor<ASIAIEMatchRecorder>(SpawnParams);
+	}
+
+	Super::StartPlay();
+}
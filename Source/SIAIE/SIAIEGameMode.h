@@ -13,6 +13,10 @@ class ASIAIEGameMode : public AGameModeBase
 
 public:
 	ASIAIEGameMode();
+
+	// AGameModeBase interface
+	virtual void StartPlay() override;
+	// End of AGameModeBase interface
 };
 
 
@@ -0,0 +1,305 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SIAIEMatchRecorder.h"
+#include "SIAIEProjectile.h"
+#include "AIController.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/BlackboardData.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Bool.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Enum.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Float.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Int.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_NativeEnum.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Vector.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Match Recorder Capture"), STAT_SIAIEMatchRecorderCapture, STATGROUP_Game);
+
+namespace
+{
+	/** Reads a bool, enum, int or float blackboard key as an integer; 0 if the key is missing. */
+	int32 ReadBlackboardInt(const UBlackboardComponent* Blackboard, FBlackboard::FKey KeyID)
+	{
+		const TSubclassOf<UBlackboardKeyType> KeyType = Blackboard->GetKeyType(KeyID);
+
+		if (KeyType == UBlackboardKeyType_Bool::StaticClass())
+		{
+			return Blackboard->GetValue<UBlackboardKeyType_Bool>(KeyID) ? 1 : 0;
+		}
+		if (KeyType == UBlackboardKeyType_Enum::StaticClass())
+		{
+			return Blackboard->GetValue<UBlackboardKeyType_Enum>(KeyID);
+		}
+		if (KeyType == UBlackboardKeyType_NativeEnum::StaticClass())
+		{
+			return Blackboard->GetValue<UBlackboardKeyType_NativeEnum>(KeyID);
+		}
+		if (KeyType == UBlackboardKeyType_Int::StaticClass())
+		{
+			return Blackboard->GetValue<UBlackboardKeyType_Int>(KeyID);
+		}
+		if (KeyType == UBlackboardKeyType_Float::StaticClass())
+		{
+			return FMath::RoundToInt(Blackboard->GetValue<UBlackboardKeyType_Float>(KeyID));
+		}
+		return 0;
+	}
+}
+
+ASIAIEMatchRecorder::ASIAIEMatchRecorder()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	SetActorHiddenInGame(true);
+
+	bEnabled = true;
+	bRecordStandalone = false;
+	MaxReplayFiles = 20;
+	SnapshotRate = 10.f;
+	SnapshotsPerChunk = 64;
+	HealthPropertyName = TEXT("Health");
+	BattleKeyName = TEXT("Battle");
+	ChaseStatusKeyName = TEXT("ChaseStatus");
+	EnemyKeyName = TEXT("Enemy");
+	TargetLocationKeyName = TEXT("TargetLocation");
+	CaptureBudgetMs = 0.2f;
+
+	NextActorId = 1;
+	NumSnapshots = 0;
+	LastNumEntities = 0;
+	TotalCaptureMs = 0.0;
+	MaxCaptureMs = 0.0;
+	NumCapturesOverBudget = 0;
+}
+
+bool ASIAIEMatchRecorder::ShouldRecord(const UWorld* World)
+{
+	const ASIAIEMatchRecorder* Defaults = GetDefault<ASIAIEMatchRecorder>();
+	if (World == nullptr || !Defaults->bEnabled)
+	{
+		return false;
+	}
+
+	const ENetMode NetMode = World->GetNetMode();
+	return NetMode == NM_DedicatedServer || NetMode == NM_ListenServer || (NetMode == NM_Standalone && Defaults->bRecordStandalone);
+}
+
+void ASIAIEMatchRecorder::BeginPlay()
+{
+	Super::BeginPlay();
+
+	const FString ReplayDir = FPaths::ProjectSavedDir() / TEXT("Replays");
+	IFileManager::Get().MakeDirectory(*ReplayDir, true);
+	DeleteOldReplays(ReplayDir);
+
+	const FString Filename = ReplayDir / FString::Printf(TEXT("%s_%s.siaiereplay"), *GetWorld()->GetMapName(), *FDateTime::Now().ToString());
+	Writer = MakeUnique<FSIAIEReplayWriter>(Filename, SnapshotRate, SnapshotsPerChunk);
+	if (!Writer->Start())
+	{
+		Writer.Reset();
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	// Snapshots only need the tick at the recording rate, not every frame
+	SetActorTickInterval(1.f / FMath::Max(SnapshotRate, 1.f));
+
+	UE_LOG(LogSIAIEReplay, Log, TEXT("Recording match to %s"), *Filename);
+}
+
+void ASIAIEMatchRecorder::DeleteOldReplays(const FString& ReplayDir) const
+{
+	if (MaxReplayFiles <= 0)
+	{
+		return;
+	}
+
+	IFileManager& FileManager = IFileManager::Get();
+
+	TArray<FString> ReplayFiles;
+	FileManager.FindFiles(ReplayFiles, *(ReplayDir / TEXT("*.siaiereplay")), true, false);
+	if (ReplayFiles.Num() < MaxReplayFiles)
+	{
+		return;
+	}
+
+	for (FString& ReplayFile : ReplayFiles)
+	{
+		ReplayFile = ReplayDir / ReplayFile;
+	}
+
+	// Oldest first, keeping room for the replay about to be written
+	ReplayFiles.Sort([&FileManager](const FString& A, const FString& B) { return FileManager.GetTimeStamp(*A) < FileManager.GetTimeStamp(*B); });
+	for (int32 Index = 0; Index <= ReplayFiles.Num() - MaxReplayFiles; ++Index)
+	{
+		FileManager.Delete(*ReplayFiles[Index]);
+	}
+}
+
+void ASIAIEMatchRecorder::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Writer.IsValid())
+	{
+		Writer->Finish();
+		Writer.Reset();
+
+		UE_LOG(LogSIAIEReplay, Log, TEXT("Recorded %d snapshots, capture took %.3f ms on average and %.3f ms at most, %d over the %.2f ms budget"),
+			NumSnapshots, TotalCaptureMs / FMath::Max(NumSnapshots, 1), MaxCaptureMs, NumCapturesOverBudget, CaptureBudgetMs);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASIAIEMatchRecorder::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (Writer.IsValid())
+	{
+		CaptureSnapshot();
+	}
+}
+
+void ASIAIEMatchRecorder::CaptureSnapshot()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SIAIEMatchRecorderCapture);
+
+	const double StartTime = FPlatformTime::Seconds();
+	UWorld* const World = GetWorld();
+
+	FSIAIEReplayFrame Frame;
+	Frame.Snapshot = NumSnapshots++;
+	Frame.WorldTime = World->GetTimeSeconds();
+	Frame.Entities.Reserve(LastNumEntities);
+
+	for (TActorIterator<APawn> It(World); It; ++It)
+	{
+		APawn* Pawn = *It;
+		if (!Pawn->IsPendingKill())
+		{
+			CapturePawn(Pawn, Frame.Entities.AddDefaulted_GetRef());
+		}
+	}
+
+	for (TActorIterator<ASIAIEProjectile> It(World); It; ++It)
+	{
+		ASIAIEProjectile* Projectile = *It;
+		if (!Projectile->IsPendingKill())
+		{
+			FSIAIEReplayEntity& Entity = Frame.Entities.AddDefaulted_GetRef();
+			Entity.Id = GetActorId(Projectile);
+			Entity.Kind = ESIAIEReplayEntityKind::Projectile;
+			Entity.ClassName = Projectile->GetClass()->GetFName();
+			Entity.SetLocation(Projectile->GetActorLocation());
+			Entity.SetRotation(Projectile->GetActorRotation());
+			Entity.SetVelocity(Projectile->GetVelocity());
+		}
+	}
+
+	LastNumEntities = Frame.Entities.Num();
+	Writer->Enqueue(MoveTemp(Frame));
+
+	const double CaptureMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	TotalCaptureMs += CaptureMs;
+	MaxCaptureMs = FMath::Max(MaxCaptureMs, CaptureMs);
+	if (CaptureMs > CaptureBudgetMs && NumCapturesOverBudget++ == 0)
+	{
+		UE_LOG(LogSIAIEReplay, Warning, TEXT("Snapshot %d of %d actors took %.3f ms, over the %.2f ms capture budget"),
+			NumSnapshots - 1, LastNumEntities, CaptureMs, CaptureBudgetMs);
+	}
+
+	// Forget destroyed actors once per chunk so short lived projectiles don't pile up
+	if (NumSnapshots % FMath::Max(SnapshotsPerChunk, 1) == 0)
+	{
+		for (auto It = ActorIds.CreateIterator(); It; ++It)
+		{
+			if (It.Key().ResolveObjectPtr() == nullptr)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+}
+
+void ASIAIEMatchRecorder::CapturePawn(APawn* Pawn, FSIAIEReplayEntity& OutEntity)
+{
+	OutEntity.Id = GetActorId(Pawn);
+	OutEntity.Kind = ESIAIEReplayEntityKind::Pawn;
+	OutEntity.ClassName = Pawn->GetClass()->GetFName();
+	OutEntity.SetLocation(Pawn->GetActorLocation());
+	OutEntity.SetRotation(Pawn->GetActorRotation());
+	OutEntity.SetVelocity(Pawn->GetVelocity());
+
+	// Health lives on the blueprint classes, so it is looked up by name
+	if (FNumericProperty* HealthProperty = FindHealthProperty(Pawn->GetClass()))
+	{
+		const void* Value = HealthProperty->ContainerPtrToValuePtr<void>(Pawn);
+		OutEntity.SetHealth(HealthProperty->IsFloatingPoint()
+			? float(HealthProperty->GetFloatingPointPropertyValue(Value))
+			: float(HealthProperty->GetSignedIntPropertyValue(Value)));
+	}
+
+	const AAIController* AIController = Cast<AAIController>(Pawn->GetController());
+	const UBlackboardComponent* Blackboard = (AIController != nullptr) ? AIController->GetBlackboardComponent() : nullptr;
+	if (Blackboard != nullptr)
+	{
+		const FRecordedBlackboardKeys& Keys = FindBlackboardKeys(Blackboard->GetBlackboardAsset());
+
+		OutEntity.Fields[FSIAIEReplayEntity::Flags] |= FSIAIEReplayEntity::HasBlackboard;
+		OutEntity.Fields[FSIAIEReplayEntity::Battle] = ReadBlackboardInt(Blackboard, Keys.Battle);
+		OutEntity.Fields[FSIAIEReplayEntity::ChaseStatus] = ReadBlackboardInt(Blackboard, Keys.ChaseStatus);
+
+		const AActor* EnemyActor = Cast<AActor>(Blackboard->GetValue<UBlackboardKeyType_Object>(Keys.Enemy));
+		OutEntity.Fields[FSIAIEReplayEntity::Enemy] = (EnemyActor != nullptr) ? GetActorId(EnemyActor) : 0;
+
+		if (Blackboard->IsVectorValueSet(Keys.TargetLocation))
+		{
+			OutEntity.SetTargetLocation(Blackboard->GetValue<UBlackboardKeyType_Vector>(Keys.TargetLocation));
+		}
+	}
+}
+
+uint32 ASIAIEMatchRecorder::GetActorId(const AActor* Actor)
+{
+	uint32& Id = ActorIds.FindOrAdd(Actor);
+	if (Id == 0)
+	{
+		Id = NextActorId++;
+	}
+	return Id;
+}
+
+FNumericProperty* ASIAIEMatchRecorder::FindHealthProperty(UClass* PawnClass)
+{
+	if (FNumericProperty** CachedProperty = HealthProperties.Find(PawnClass))
+	{
+		return *CachedProperty;
+	}
+
+	FNumericProperty* HealthProperty = FindFProperty<FNumericProperty>(PawnClass, HealthPropertyName);
+	HealthProperties.Add(PawnClass, HealthProperty);
+	return HealthProperty;
+}
+
+const ASIAIEMatchRecorder::FRecordedBlackboardKeys& ASIAIEMatchRecorder::FindBlackboardKeys(const UBlackboardData* BlackboardAsset)
+{
+	if (const FRecordedBlackboardKeys* CachedKeys = BlackboardKeys.Find(BlackboardAsset))
+	{
+		return *CachedKeys;
+	}
+
+	// GetKeyID walks the key list and the parent assets, so it is only done once per asset
+	FRecordedBlackboardKeys Keys;
+	if (BlackboardAsset != nullptr)
+	{
+		Keys.Battle = BlackboardAsset->GetKeyID(BattleKeyName);
+		Keys.ChaseStatus = BlackboardAsset->GetKeyID(ChaseStatusKeyName);
+		Keys.Enemy = BlackboardAsset->GetKeyID(EnemyKeyName);
+		Keys.TargetLocation = BlackboardAsset->GetKeyID(TargetLocationKeyName);
+	}
+	return BlackboardKeys.Add(BlackboardAsset, Keys);
+}
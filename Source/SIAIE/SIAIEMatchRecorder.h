@@ -0,0 +1,125 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "UObject/ObjectKey.h"
+#include "BehaviorTree/BehaviorTreeTypes.h"
+#include "SIAIEReplayFile.h"
+#include "SIAIEMatchRecorder.generated.h"
+
+class APawn;
+class FNumericProperty;
+class UBlackboardData;
+
+/**
+ * Server-side match recorder. Snapshots every pawn (transform, health and AI blackboard state)
+ * and every live projectile at SnapshotRate and streams them to Saved/Replays through a
+ * FSIAIEReplayWriter. Only capture runs on the game thread; encoding and IO are off-thread.
+ */
+UCLASS(config=Game, notplaceable)
+class ASIAIEMatchRecorder : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ASIAIEMatchRecorder();
+
+	/** Whether matches of the given world should be recorded */
+	static bool ShouldRecord(const UWorld* World);
+
+	/** Whether matches are recorded at all */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Recording)
+	uint8 bEnabled : 1;
+
+	/** Also record standalone and PIE sessions, not only dedicated and listen servers */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Recording)
+	uint8 bRecordStandalone : 1;
+
+	/** Most replay files kept in Saved/Replays, the oldest are deleted when a recording starts. 0 keeps all */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Recording, meta=(ClampMin="0"))
+	int32 MaxReplayFiles;
+
+	/** Snapshots taken per second */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Recording, meta=(ClampMin="1"))
+	float SnapshotRate;
+
+	/** Snapshots per compressed chunk; each chunk starts with a keyframe */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Recording, meta=(ClampMin="1"))
+	int32 SnapshotsPerChunk;
+
+	/** Numeric property read from pawns as their health, if they have one */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Recording)
+	FName HealthPropertyName;
+
+	/** Blackboard keys recorded for AI controlled pawns */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Recording)
+	FName BattleKeyName;
+
+	UPROPERTY(Config, EditDefaultsOnly, Category=Recording)
+	FName ChaseStatusKeyName;
+
+	UPROPERTY(Config, EditDefaultsOnly, Category=Recording)
+	FName EnemyKeyName;
+
+	UPROPERTY(Config, EditDefaultsOnly, Category=Recording)
+	FName TargetLocationKeyName;
+
+	/** Game thread time a snapshot may take; longer captures are reported in the log */
+	UPROPERTY(Config, EditDefaultsOnly, Category=Recording)
+	float CaptureBudgetMs;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	virtual void Tick(float DeltaSeconds) override;
+
+private:
+	/** Deletes the oldest replays so that a new one stays within MaxReplayFiles */
+	void DeleteOldReplays(const FString& ReplayDir) const;
+
+	/** Ids of the recorded keys in one blackboard asset */
+	struct FRecordedBlackboardKeys
+	{
+		FBlackboard::FKey Battle = FBlackboard::InvalidKey;
+		FBlackboard::FKey ChaseStatus = FBlackboard::InvalidKey;
+		FBlackboard::FKey Enemy = FBlackboard::InvalidKey;
+		FBlackboard::FKey TargetLocation = FBlackboard::InvalidKey;
+	};
+
+	/** Gathers the current state of all recorded actors and hands it to the writer */
+	void CaptureSnapshot();
+
+	void CapturePawn(APawn* Pawn, FSIAIEReplayEntity& OutEntity);
+
+	/** Returns the recording id of an actor, assigning a new one the first time it is seen */
+	uint32 GetActorId(const AActor* Actor);
+
+	/** Returns the health property of a pawn class, cached per class */
+	FNumericProperty* FindHealthProperty(UClass* PawnClass);
+
+	/** Returns the ids of the recorded keys, resolved once per blackboard asset */
+	const FRecordedBlackboardKeys& FindBlackboardKeys(const UBlackboardData* BlackboardAsset);
+
+	TUniquePtr<FSIAIEReplayWriter> Writer;
+
+	TMap<TObjectKey<AActor>, uint32> ActorIds;
+	uint32 NextActorId;
+
+	TMap<TObjectKey<UClass>, FNumericProperty*> HealthProperties;
+
+	TMap<TObjectKey<UBlackboardData>, FRecordedBlackboardKeys> BlackboardKeys;
+
+	int32 NumSnapshots;
+
+	/** Entity count of the last snapshot, used to size the next one */
+	int32 LastNumEntities;
+
+	/** Capture cost statistics, logged when the recording ends */
+	double TotalCaptureMs;
+	double MaxCaptureMs;
+	int32 NumCapturesOverBudget;
+};
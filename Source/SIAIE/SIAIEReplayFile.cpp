@@ -0,0 +1,656 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SIAIEReplayFile.h"
+#include "Algo/BinarySearch.h"
+#include "HAL/FileManager.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY(LogSIAIEReplay);
+
+namespace SIAIEReplay
+{
+	static const uint32 FileMagic = 0x50524953;		// "SIRP"
+	static const uint32 FooterMagic = 0x58444E49;	// "INDX"
+	static const uint32 FileVersion = 1;
+
+	/** FirstSnapshot, NumFrames, FirstTime, UncompressedSize, CompressedSize */
+	static const int64 ChunkHeaderSize = 5 * sizeof(int32);
+	/** IndexOffset, NumChunks, FooterMagic */
+	static const int64 FooterSize = sizeof(int64) + 2 * sizeof(int32);
+
+	/** Set in the entity mask when the entity was not part of the previous frame */
+	static const uint32 NewEntityBit = 1u << FSIAIEReplayEntity::NumFields;
+
+	static uint32 ZigZagEncode(int32 Value)
+	{
+		return (uint32(Value) << 1) ^ uint32(Value >> 31);
+	}
+
+	static int32 ZigZagDecode(uint32 Value)
+	{
+		return int32(Value >> 1) ^ -int32(Value & 1);
+	}
+
+	static void SerializePacked(FArchive& Ar, uint32 Value)
+	{
+		Ar.SerializeIntPacked(Value);
+	}
+
+	static uint32 ReadPacked(FArchive& Ar)
+	{
+		uint32 Value = 0;
+		Ar.SerializeIntPacked(Value);
+		return Value;
+	}
+
+	/** Writes the changes between Baseline and Frame, then updates Baseline to Frame. */
+	static void EncodeFrame(FArchive& Ar, const FSIAIEReplayFrame& Frame, TMap<uint32, FSIAIEReplayEntity>& Baseline)
+	{
+		SerializePacked(Ar, uint32(Frame.Snapshot));
+		float WorldTime = Frame.WorldTime;
+		Ar << WorldTime;
+
+		TSet<uint32> LiveIds;
+		LiveIds.Reserve(Frame.Entities.Num());
+		for (const FSIAIEReplayEntity& Entity : Frame.Entities)
+		{
+			LiveIds.Add(Entity.Id);
+		}
+
+		TArray<uint32> RemovedIds;
+		for (const TPair<uint32, FSIAIEReplayEntity>& Pair : Baseline)
+		{
+			if (!LiveIds.Contains(Pair.Key))
+			{
+				RemovedIds.Add(Pair.Key);
+			}
+		}
+
+		SerializePacked(Ar, RemovedIds.Num());
+		for (uint32 Id : RemovedIds)
+		{
+			SerializePacked(Ar, Id);
+			Baseline.Remove(Id);
+		}
+
+		// Count changed entities first so unchanged ones cost nothing
+		static const FSIAIEReplayEntity EmptyEntity;
+		TArray<uint32, TInlineAllocator<256>> Masks;
+		Masks.SetNumUninitialized(Frame.Entities.Num());
+		int32 NumChanged = 0;
+		for (int32 EntityIndex = 0; EntityIndex < Frame.Entities.Num(); ++EntityIndex)
+		{
+			const FSIAIEReplayEntity& Entity = Frame.Entities[EntityIndex];
+			const FSIAIEReplayEntity* Previous = Baseline.Find(Entity.Id);
+
+			uint32 Mask = (Previous == nullptr) ? NewEntityBit : 0;
+			const FSIAIEReplayEntity& Base = (Previous != nullptr) ? *Previous : EmptyEntity;
+			for (int32 Field = 0; Field < FSIAIEReplayEntity::NumFields; ++Field)
+			{
+				if (Entity.Fields[Field] != Base.Fields[Field])
+				{
+					Mask |= 1u << Field;
+				}
+			}
+
+			Masks[EntityIndex] = Mask;
+			NumChanged += (Mask != 0) ? 1 : 0;
+		}
+
+		SerializePacked(Ar, NumChanged);
+		for (int32 EntityIndex = 0; EntityIndex < Frame.Entities.Num(); ++EntityIndex)
+		{
+			const uint32 Mask = Masks[EntityIndex];
+			if (Mask == 0)
+			{
+				continue;
+			}
+
+			const FSIAIEReplayEntity& Entity = Frame.Entities[EntityIndex];
+			FSIAIEReplayEntity& Base = Baseline.FindOrAdd(Entity.Id);
+
+			SerializePacked(Ar, Entity.Id);
+			SerializePacked(Ar, Mask);
+			if (Mask & NewEntityBit)
+			{
+				uint8 Kind = uint8(Entity.Kind);
+				FName ClassName = Entity.ClassName;
+				Ar << Kind << ClassName;
+			}
+
+			for (int32 Field = 0; Field < FSIAIEReplayEntity::NumFields; ++Field)
+			{
+				if (Mask & (1u << Field))
+				{
+					const int32 Delta = int32(uint32(Entity.Fields[Field]) - uint32(Base.Fields[Field]));
+					SerializePacked(Ar, ZigZagEncode(Delta));
+				}
+			}
+
+			Base = Entity;
+		}
+	}
+
+	/** Applies one encoded frame on top of Baseline and returns the resulting state. */
+	static bool DecodeFrame(FArchive& Ar, FSIAIEReplayFrame& OutFrame, TMap<uint32, FSIAIEReplayEntity>& Baseline)
+	{
+		OutFrame.Snapshot = int32(ReadPacked(Ar));
+		Ar << OutFrame.WorldTime;
+
+		const uint32 NumRemoved = ReadPacked(Ar);
+		for (uint32 Index = 0; Index < NumRemoved && !Ar.IsError(); ++Index)
+		{
+			Baseline.Remove(ReadPacked(Ar));
+		}
+
+		const uint32 NumChanged = ReadPacked(Ar);
+		for (uint32 Index = 0; Index < NumChanged && !Ar.IsError(); ++Index)
+		{
+			const uint32 Id = ReadPacked(Ar);
+			const uint32 Mask = ReadPacked(Ar);
+
+			FSIAIEReplayEntity& Entity = Baseline.FindOrAdd(Id);
+			if (Mask & NewEntityBit)
+			{
+				Entity = FSIAIEReplayEntity();
+				Entity.Id = Id;
+
+				uint8 Kind = 0;
+				Ar << Kind << Entity.ClassName;
+				Entity.Kind = ESIAIEReplayEntityKind(Kind);
+			}
+
+			for (int32 Field = 0; Field < FSIAIEReplayEntity::NumFields; ++Field)
+			{
+				if (Mask & (1u << Field))
+				{
+					Entity.Fields[Field] = int32(uint32(Entity.Fields[Field]) + uint32(ZigZagDecode(ReadPacked(Ar))));
+				}
+			}
+		}
+
+		Baseline.GenerateValueArray(OutFrame.Entities);
+		OutFrame.Entities.Sort([](const FSIAIEReplayEntity& A, const FSIAIEReplayEntity& B) { return A.Id < B.Id; });
+
+		return !Ar.IsError();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSIAIEReplayEntity
+
+void FSIAIEReplayEntity::SetLocation(const FVector& Location)
+{
+	Fields[LocationX] = FMath::RoundToInt(Location.X * LocationScale);
+	Fields[LocationY] = FMath::RoundToInt(Location.Y * LocationScale);
+	Fields[LocationZ] = FMath::RoundToInt(Location.Z * LocationScale);
+}
+
+void FSIAIEReplayEntity::SetRotation(const FRotator& Rotation)
+{
+	Fields[Pitch] = FRotator::CompressAxisToShort(Rotation.Pitch);
+	Fields[Yaw] = FRotator::CompressAxisToShort(Rotation.Yaw);
+	Fields[Roll] = FRotator::CompressAxisToShort(Rotation.Roll);
+}
+
+void FSIAIEReplayEntity::SetVelocity(const FVector& Velocity)
+{
+	Fields[VelocityX] = FMath::RoundToInt(Velocity.X);
+	Fields[VelocityY] = FMath::RoundToInt(Velocity.Y);
+	Fields[VelocityZ] = FMath::RoundToInt(Velocity.Z);
+}
+
+void FSIAIEReplayEntity::SetHealth(float InHealth)
+{
+	Fields[Health] = FMath::RoundToInt(InHealth * HealthScale);
+	Fields[Flags] |= HasHealth;
+}
+
+void FSIAIEReplayEntity::SetTargetLocation(const FVector& Location)
+{
+	Fields[TargetLocationX] = FMath::RoundToInt(Location.X * LocationScale);
+	Fields[TargetLocationY] = FMath::RoundToInt(Location.Y * LocationScale);
+	Fields[TargetLocationZ] = FMath::RoundToInt(Location.Z * LocationScale);
+	Fields[Flags] |= HasTargetLocation;
+}
+
+FVector FSIAIEReplayEntity::GetLocation() const
+{
+	return FVector(Fields[LocationX], Fields[LocationY], Fields[LocationZ]) / LocationScale;
+}
+
+FRotator FSIAIEReplayEntity::GetRotation() const
+{
+	return FRotator(
+		FRotator::DecompressAxisFromShort(uint16(Fields[Pitch])),
+		FRotator::DecompressAxisFromShort(uint16(Fields[Yaw])),
+		FRotator::DecompressAxisFromShort(uint16(Fields[Roll])));
+}
+
+FVector FSIAIEReplayEntity::GetVelocity() const
+{
+	return FVector(Fields[VelocityX], Fields[VelocityY], Fields[VelocityZ]);
+}
+
+float FSIAIEReplayEntity::GetHealth() const
+{
+	return Fields[Health] / HealthScale;
+}
+
+FVector FSIAIEReplayEntity::GetTargetLocation() const
+{
+	return FVector(Fields[TargetLocationX], Fields[TargetLocationY], Fields[TargetLocationZ]) / LocationScale;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSIAIEReplayWriter
+
+FSIAIEReplayWriter::FSIAIEReplayWriter(const FString& InFilename, float InSnapshotRate, int32 InFramesPerChunk)
+	: Filename(InFilename)
+	, SnapshotRate(InSnapshotRate)
+	, FramesPerChunk(FMath::Max(1, InFramesPerChunk))
+	, WorkEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, Thread(nullptr)
+	, bStopping(false)
+{
+}
+
+FSIAIEReplayWriter::~FSIAIEReplayWriter()
+{
+	Finish();
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+}
+
+bool FSIAIEReplayWriter::Start()
+{
+	FileWriter.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!FileWriter.IsValid())
+	{
+		UE_LOG(LogSIAIEReplay, Warning, TEXT("Could not open replay file %s"), *Filename);
+		return false;
+	}
+
+	uint32 Magic = SIAIEReplay::FileMagic;
+	uint32 Version = SIAIEReplay::FileVersion;
+	*FileWriter << Magic << Version << SnapshotRate << FramesPerChunk;
+
+	// Without threading support the frames are encoded inline in Enqueue()
+	if (FPlatformProcess::SupportsMultithreading())
+	{
+		Thread = FRunnableThread::Create(this, TEXT("SIAIEReplayWriter"), 0, TPri_BelowNormal);
+	}
+
+	return true;
+}
+
+void FSIAIEReplayWriter::Enqueue(FSIAIEReplayFrame&& Frame)
+{
+	if (!FileWriter.IsValid() || bStopping)
+	{
+		return;
+	}
+
+	PendingFrames.Enqueue(MoveTemp(Frame));
+
+	if (Thread != nullptr)
+	{
+		WorkEvent->Trigger();
+	}
+	else
+	{
+		ProcessPendingFrames();
+	}
+}
+
+void FSIAIEReplayWriter::Finish()
+{
+	if (Thread != nullptr)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+	else if (FileWriter.IsValid())
+	{
+		bStopping = true;
+		Run();
+	}
+}
+
+uint32 FSIAIEReplayWriter::Run()
+{
+	while (!bStopping)
+	{
+		WorkEvent->Wait();
+		ProcessPendingFrames();
+	}
+
+	// Drain whatever arrived after the last wake up, then close the file with its index
+	ProcessPendingFrames();
+	FlushChunk();
+
+	int64 IndexOffset = FileWriter->Tell();
+	int32 NumChunks = Index.Num();
+	for (FSIAIEReplayChunkInfo& Info : Index)
+	{
+		*FileWriter << Info;
+	}
+
+	uint32 Magic = SIAIEReplay::FooterMagic;
+	*FileWriter << IndexOffset << NumChunks << Magic;
+
+	FileWriter->Close();
+	FileWriter.Reset();
+
+	UE_LOG(LogSIAIEReplay, Log, TEXT("Wrote %d replay chunks to %s"), NumChunks, *Filename);
+	return 0;
+}
+
+void FSIAIEReplayWriter::Stop()
+{
+	bStopping = true;
+	WorkEvent->Trigger();
+}
+
+void FSIAIEReplayWriter::ProcessPendingFrames()
+{
+	FSIAIEReplayFrame Frame;
+	while (PendingFrames.Dequeue(Frame))
+	{
+		WriteFrame(Frame);
+	}
+}
+
+void FSIAIEReplayWriter::WriteFrame(const FSIAIEReplayFrame& Frame)
+{
+	if (CurrentChunk.NumFrames == 0)
+	{
+		// Start of a chunk: an empty baseline makes the first frame a keyframe
+		Baseline.Reset();
+		CurrentChunk.FirstSnapshot = Frame.Snapshot;
+		CurrentChunk.FirstTime = Frame.WorldTime;
+	}
+
+	FMemoryWriter Ar(ChunkData);
+	Ar.Seek(ChunkData.Num());
+	SIAIEReplay::EncodeFrame(Ar, Frame, Baseline);
+
+	if (++CurrentChunk.NumFrames >= FramesPerChunk)
+	{
+		FlushChunk();
+	}
+}
+
+void FSIAIEReplayWriter::FlushChunk()
+{
+	if (CurrentChunk.NumFrames == 0)
+	{
+		return;
+	}
+
+	int32 UncompressedSize = ChunkData.Num();
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, UncompressedSize);
+
+	TArray<uint8> CompressedData;
+	CompressedData.SetNumUninitialized(CompressedSize);
+	if (!FCompression::CompressMemory(NAME_Zlib, CompressedData.GetData(), CompressedSize, ChunkData.GetData(), UncompressedSize))
+	{
+		UE_LOG(LogSIAIEReplay, Warning, TEXT("Failed to compress replay chunk at snapshot %d"), CurrentChunk.FirstSnapshot);
+		CompressedSize = 0;
+	}
+
+	if (CompressedSize > 0)
+	{
+		CurrentChunk.Offset = FileWriter->Tell();
+		*FileWriter << CurrentChunk.FirstSnapshot << CurrentChunk.NumFrames << CurrentChunk.FirstTime << UncompressedSize << CompressedSize;
+		FileWriter->Serialize(CompressedData.GetData(), CompressedSize);
+
+		// Keep the data on disk usable even if the match never ends cleanly
+		FileWriter->Flush();
+
+		Index.Add(CurrentChunk);
+	}
+
+	ChunkData.Reset();
+	CurrentChunk = FSIAIEReplayChunkInfo();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSIAIEReplayReader
+
+bool FSIAIEReplayReader::Open(const FString& Filename)
+{
+	FileReader.Reset(IFileManager::Get().CreateFileReader(*Filename));
+	if (!FileReader.IsValid())
+	{
+		UE_LOG(LogSIAIEReplay, Warning, TEXT("Could not open replay file %s"), *Filename);
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	*FileReader << Magic << Version << SnapshotRate << FramesPerChunk;
+	if (FileReader->IsError() || Magic != SIAIEReplay::FileMagic || Version != SIAIEReplay::FileVersion)
+	{
+		UE_LOG(LogSIAIEReplay, Warning, TEXT("%s is not a supported replay file"), *Filename);
+		FileReader.Reset();
+		return false;
+	}
+
+	FirstChunkOffset = FileReader->Tell();
+	LoadedChunk = INDEX_NONE;
+	LoadedFrames.Reset();
+
+	if (!ReadIndex() && !RebuildIndex())
+	{
+		FileReader.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+int32 FSIAIEReplayReader::GetNumSnapshots() const
+{
+	return (Index.Num() > 0) ? Index.Last().FirstSnapshot + Index.Last().NumFrames : 0;
+}
+
+bool FSIAIEReplayReader::ReadSnapshot(int32 Snapshot, FSIAIEReplayFrame& OutFrame)
+{
+	if (!FileReader.IsValid() || Index.Num() == 0)
+	{
+		return false;
+	}
+
+	// Last chunk starting at or before the requested snapshot
+	const int32 ChunkIndex = Algo::UpperBoundBy(Index, Snapshot, &FSIAIEReplayChunkInfo::FirstSnapshot) - 1;
+	if (!Index.IsValidIndex(ChunkIndex) || !LoadChunk(ChunkIndex))
+	{
+		return false;
+	}
+
+	const int32 FrameIndex = Snapshot - Index[ChunkIndex].FirstSnapshot;
+	if (!LoadedFrames.IsValidIndex(FrameIndex))
+	{
+		return false;
+	}
+
+	OutFrame = LoadedFrames[FrameIndex];
+	return true;
+}
+
+int32 FSIAIEReplayReader::FindSnapshotAtTime(float WorldTime) const
+{
+	if (Index.Num() == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 ChunkIndex = FMath::Max(0, Algo::UpperBoundBy(Index, WorldTime, &FSIAIEReplayChunkInfo::FirstTime) - 1);
+	const FSIAIEReplayChunkInfo& Info = Index[ChunkIndex];
+	const int32 Offset = FMath::RoundToInt((WorldTime - Info.FirstTime) * SnapshotRate);
+	return Info.FirstSnapshot + FMath::Clamp(Offset, 0, Info.NumFrames - 1);
+}
+
+bool FSIAIEReplayReader::ReadIndex()
+{
+	const int64 TotalSize = FileReader->TotalSize();
+	if (TotalSize < FirstChunkOffset + SIAIEReplay::FooterSize)
+	{
+		return false;
+	}
+
+	int64 IndexOffset = 0;
+	int32 NumChunks = 0;
+	uint32 Magic = 0;
+	FileReader->Seek(TotalSize - SIAIEReplay::FooterSize);
+	*FileReader << IndexOffset << NumChunks << Magic;
+
+	const int64 IndexSize = int64(NumChunks) * (3 * sizeof(int32) + sizeof(int64));
+	if (FileReader->IsError() || Magic != SIAIEReplay::FooterMagic || NumChunks < 0
+		|| IndexOffset < FirstChunkOffset || IndexOffset + IndexSize != TotalSize - SIAIEReplay::FooterSize)
+	{
+		FileReader->ClearError();
+		return false;
+	}
+
+	FileReader->Seek(IndexOffset);
+	Index.SetNum(NumChunks);
+	for (FSIAIEReplayChunkInfo& Info : Index)
+	{
+		*FileReader << Info;
+	}
+
+	return !FileReader->IsError();
+}
+
+bool FSIAIEReplayReader::RebuildIndex()
+{
+	UE_LOG(LogSIAIEReplay, Log, TEXT("Replay file has no index, scanning chunks"));
+
+	Index.Reset();
+
+	const int64 TotalSize = FileReader->TotalSize();
+	int64 Offset = FirstChunkOffset;
+	while (Offset + SIAIEReplay::ChunkHeaderSize <= TotalSize)
+	{
+		FSIAIEReplayChunkInfo Info;
+		Info.Offset = Offset;
+
+		int32 UncompressedSize = 0;
+		int32 CompressedSize = 0;
+		FileReader->Seek(Offset);
+		*FileReader << Info.FirstSnapshot << Info.NumFrames << Info.FirstTime << UncompressedSize << CompressedSize;
+
+		// A truncated trailing chunk is expected after a crash, stop there
+		const int64 NextOffset = Offset + SIAIEReplay::ChunkHeaderSize + CompressedSize;
+		if (FileReader->IsError() || Info.NumFrames <= 0 || CompressedSize <= 0 || NextOffset > TotalSize)
+		{
+			break;
+		}
+
+		Index.Add(Info);
+		Offset = NextOffset;
+	}
+
+	FileReader->ClearError();
+	return Index.Num() > 0;
+}
+
+bool FSIAIEReplayReader::LoadChunk(int32 ChunkIndex)
+{
+	if (ChunkIndex == LoadedChunk)
+	{
+		return true;
+	}
+
+	const FSIAIEReplayChunkInfo& Info = Index[ChunkIndex];
+
+	FSIAIEReplayChunkInfo Header;
+	int32 UncompressedSize = 0;
+	int32 CompressedSize = 0;
+	FileReader->Seek(Info.Offset);
+	*FileReader << Header.FirstSnapshot << Header.NumFrames << Header.FirstTime << UncompressedSize << CompressedSize;
+	if (FileReader->IsError() || Header.FirstSnapshot != Info.FirstSnapshot || UncompressedSize < 0 || CompressedSize <= 0)
+	{
+		FileReader->ClearError();
+		return false;
+	}
+
+	TArray<uint8> CompressedData;
+	CompressedData.SetNumUninitialized(CompressedSize);
+	FileReader->Serialize(CompressedData.GetData(), CompressedSize);
+
+	TArray<uint8> ChunkData;
+	ChunkData.SetNumUninitialized(UncompressedSize);
+	if (FileReader->IsError() || !FCompression::UncompressMemory(NAME_Zlib, ChunkData.GetData(), UncompressedSize, CompressedData.GetData(), CompressedSize))
+	{
+		FileReader->ClearError();
+		return false;
+	}
+
+	LoadedChunk = INDEX_NONE;
+	LoadedFrames.Reset();
+	LoadedFrames.SetNum(Header.NumFrames);
+
+	TMap<uint32, FSIAIEReplayEntity> Baseline;
+	FMemoryReader Ar(ChunkData);
+	for (FSIAIEReplayFrame& Frame : LoadedFrames)
+	{
+		if (!SIAIEReplay::DecodeFrame(Ar, Frame, Baseline))
+		{
+			LoadedFrames.Reset();
+			return false;
+		}
+	}
+
+	LoadedChunk = ChunkIndex;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Console
+
+static FAutoConsoleCommand CmdDumpReplaySnapshot(
+	TEXT("SIAIE.Replay.Dump"),
+	TEXT("Logs every recorded actor at a snapshot of a match replay. Usage: SIAIE.Replay.Dump <File> <Snapshot>"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		if (Args.Num() < 2)
+		{
+			UE_LOG(LogSIAIEReplay, Display, TEXT("Usage: SIAIE.Replay.Dump <File> <Snapshot>"));
+			return;
+		}
+
+		FSIAIEReplayReader Reader;
+		FSIAIEReplayFrame Frame;
+		if (!Reader.Open(Args[0]) || !Reader.ReadSnapshot(FCString::Atoi(*Args[1]), Frame))
+		{
+			UE_LOG(LogSIAIEReplay, Display, TEXT("Snapshot %s not found in %s"), *Args[1], *Args[0]);
+			return;
+		}
+
+		UE_LOG(LogSIAIEReplay, Display, TEXT("Snapshot %d/%d, time %.2f, %d actors"), Frame.Snapshot, Reader.GetNumSnapshots(), Frame.WorldTime, Frame.Entities.Num());
+		for (const FSIAIEReplayEntity& Entity : Frame.Entities)
+		{
+			const int32 Flags = Entity.Fields[FSIAIEReplayEntity::Flags];
+			UE_LOG(LogSIAIEReplay, Display, TEXT("  [%u] %s Loc=(%s) Rot=(%s) Vel=(%s) Health=%s"),
+				Entity.Id, *Entity.ClassName.ToString(),
+				*Entity.GetLocation().ToCompactString(), *Entity.GetRotation().ToCompactString(), *Entity.GetVelocity().ToCompactString(),
+				(Flags & FSIAIEReplayEntity::HasHealth) ? *FString::SanitizeFloat(Entity.GetHealth()) : TEXT("n/a"));
+
+			if (Flags & FSIAIEReplayEntity::HasBlackboard)
+			{
+				UE_LOG(LogSIAIEReplay, Display, TEXT("      Battle=%d ChaseStatus=%d Enemy=%d TargetLocation=%s"),
+					Entity.Fields[FSIAIEReplayEntity::Battle], Entity.Fields[FSIAIEReplayEntity::ChaseStatus], Entity.Fields[FSIAIEReplayEntity::Enemy],
+					(Flags & FSIAIEReplayEntity::HasTargetLocation) ? *Entity.GetTargetLocation().ToCompactString() : TEXT("unset"));
+			}
+		}
+	}));
@@ -0,0 +1,184 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Containers/Queue.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogSIAIEReplay, Log, All);
+
+/**
+ * Match replay file layout (all values little endian):
+ *
+ *   Header   : Magic, Version, SnapshotRate, FramesPerChunk
+ *   Chunk[N] : FirstSnapshot, NumFrames, FirstTime, UncompressedSize, CompressedSize, zlib payload
+ *   Index    : one FSIAIEReplayChunkInfo per chunk
+ *   Footer   : IndexOffset, NumChunks, FooterMagic
+ *
+ * The first frame of every chunk is a keyframe (delta against an empty state), the following
+ * frames are deltas against the previous frame, so any snapshot can be rebuilt by decoding a
+ * single chunk. If the footer is missing (e.g. the server crashed) the index is rebuilt by
+ * walking the chunk headers.
+ */
+
+enum class ESIAIEReplayEntityKind : uint8
+{
+	Pawn,
+	Projectile,
+};
+
+/** Quantized state of one recorded actor. Every field is delta encoded independently. */
+struct FSIAIEReplayEntity
+{
+	enum EField
+	{
+		LocationX, LocationY, LocationZ,
+		Pitch, Yaw, Roll,
+		VelocityX, VelocityY, VelocityZ,
+		Health,
+		Battle,
+		ChaseStatus,
+		Enemy,
+		TargetLocationX, TargetLocationY, TargetLocationZ,
+		Flags,
+		NumFields
+	};
+
+	enum EFlags
+	{
+		HasHealth = 1 << 0,
+		HasBlackboard = 1 << 1,
+		HasTargetLocation = 1 << 2,
+	};
+
+	/** Locations are stored in millimetres, health in hundredths. */
+	static constexpr float LocationScale = 10.f;
+	static constexpr float HealthScale = 100.f;
+
+	FSIAIEReplayEntity() { FMemory::Memzero(Fields); }
+
+	/** Recorder-assigned id, stable for the lifetime of the actor in one recording */
+	uint32 Id = 0;
+
+	ESIAIEReplayEntityKind Kind = ESIAIEReplayEntityKind::Pawn;
+
+	FName ClassName;
+
+	int32 Fields[NumFields];
+
+	void SetLocation(const FVector& Location);
+	void SetRotation(const FRotator& Rotation);
+	void SetVelocity(const FVector& Velocity);
+	void SetHealth(float InHealth);
+	void SetTargetLocation(const FVector& Location);
+
+	FVector GetLocation() const;
+	FRotator GetRotation() const;
+	FVector GetVelocity() const;
+	float GetHealth() const;
+	FVector GetTargetLocation() const;
+};
+
+/** All recorded actors at one snapshot. */
+struct FSIAIEReplayFrame
+{
+	int32 Snapshot = 0;
+	float WorldTime = 0.f;
+	TArray<FSIAIEReplayEntity> Entities;
+};
+
+struct FSIAIEReplayChunkInfo
+{
+	int32 FirstSnapshot = 0;
+	int32 NumFrames = 0;
+	float FirstTime = 0.f;
+	int64 Offset = 0;
+
+	friend FArchive& operator<<(FArchive& Ar, FSIAIEReplayChunkInfo& Info)
+	{
+		return Ar << Info.FirstSnapshot << Info.NumFrames << Info.FirstTime << Info.Offset;
+	}
+};
+
+/**
+ * Encodes, compresses and writes snapshots on a background thread.
+ * Enqueue() is the only call made per snapshot on the game thread.
+ */
+class FSIAIEReplayWriter : public FRunnable
+{
+public:
+	FSIAIEReplayWriter(const FString& InFilename, float InSnapshotRate, int32 InFramesPerChunk);
+	virtual ~FSIAIEReplayWriter();
+
+	/** Opens the file and starts the writer thread. */
+	bool Start();
+
+	/** Hands a captured snapshot over to the writer thread. */
+	void Enqueue(FSIAIEReplayFrame&& Frame);
+
+	/** Flushes pending snapshots, writes the index and closes the file. Blocks until done. */
+	void Finish();
+
+	const FString& GetFilename() const { return Filename; }
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	// End of FRunnable interface
+
+private:
+	void ProcessPendingFrames();
+	void WriteFrame(const FSIAIEReplayFrame& Frame);
+	void FlushChunk();
+
+	FString Filename;
+	float SnapshotRate;
+	int32 FramesPerChunk;
+
+	TQueue<FSIAIEReplayFrame, EQueueMode::Spsc> PendingFrames;
+	FEvent* WorkEvent;
+	FRunnableThread* Thread;
+	FThreadSafeBool bStopping;
+
+	TUniquePtr<FArchive> FileWriter;
+	TArray<FSIAIEReplayChunkInfo> Index;
+
+	/** Delta encoded frames of the chunk being built */
+	TArray<uint8> ChunkData;
+	FSIAIEReplayChunkInfo CurrentChunk;
+
+	/** Last written state of every entity, used as the delta baseline */
+	TMap<uint32, FSIAIEReplayEntity> Baseline;
+};
+
+/** Random access reader for files produced by FSIAIEReplayWriter. */
+class FSIAIEReplayReader
+{
+public:
+	bool Open(const FString& Filename);
+
+	int32 GetNumSnapshots() const;
+	float GetSnapshotRate() const { return SnapshotRate; }
+
+	/** Rebuilds the state at the given snapshot, decoding only the chunk that contains it. */
+	bool ReadSnapshot(int32 Snapshot, FSIAIEReplayFrame& OutFrame);
+
+	/** Returns the snapshot closest to the given world time. */
+	int32 FindSnapshotAtTime(float WorldTime) const;
+
+private:
+	bool ReadIndex();
+	bool RebuildIndex();
+	bool LoadChunk(int32 ChunkIndex);
+
+	TUniquePtr<FArchive> FileReader;
+	float SnapshotRate = 0.f;
+	int32 FramesPerChunk = 0;
+	int64 FirstChunkOffset = 0;
+	TArray<FSIAIEReplayChunkInfo> Index;
+
+	int32 LoadedChunk = INDEX_NONE;
+	TArray<FSIAIEReplayFrame> LoadedFrames;
+};